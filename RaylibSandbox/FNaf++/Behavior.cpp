@@ -0,0 +1,168 @@
+#include "Behavior.h"
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <new>
+
+#pragma region Frame pool
+
+namespace {
+	// The free list and chunks for one thread
+	// @ thread_local means each thread gets its own copy of this, so the pool never needs a lock.
+	struct FramePoolState {
+		struct Block { Block* next; }; // A free block stores a pointer to the next free block inside itself
+
+		Block* freeList = nullptr;
+		std::vector<void*> chunks;
+
+		~FramePoolState() {
+			for (void* chunk : chunks) { ::operator delete(chunk); }
+		}
+
+		// Carve a new chunk into blocks and push them all onto the free list
+		void Grow() {
+			char* chunk = (char*)::operator new(BehaviorFramePool::blockSize * BehaviorFramePool::blocksPerChunk);
+			chunks.push_back(chunk);
+			for (std::size_t i = 0; i < BehaviorFramePool::blocksPerChunk; ++i) {
+				Block* block = (Block*)(chunk + i * BehaviorFramePool::blockSize);
+				block->next = freeList;
+				freeList = block;
+			}
+		}
+	};
+	thread_local FramePoolState framePool;
+}
+
+void* BehaviorFramePool::Allocate(std::size_t size) {
+	if (size > blockSize) return ::operator new(size); // @ Only happens if somebody writes a script with a lot of locals; it still works, it just isn't pooled.
+	if (!framePool.freeList) framePool.Grow();
+	FramePoolState::Block* block = framePool.freeList;
+	framePool.freeList = block->next;
+	return block;
+}
+
+void BehaviorFramePool::Free(void* frame, std::size_t size) {
+	if (size > blockSize) { ::operator delete(frame); return; }
+	FramePoolState::Block* block = (FramePoolState::Block*)frame;
+	block->next = framePool.freeList;
+	framePool.freeList = block;
+}
+
+#pragma endregion
+
+#pragma region Scheduler
+
+void Behavior::promise_type::unhandled_exception() {
+	std::terminate(); // Scripts aren't expected to throw; if one does, there is no sensible frame to resume it on.
+}
+
+void Behavior::promise_type::OpportunityAwaiter::await_suspend(std::coroutine_handle<promise_type> handle) const {
+	promise.wakeFrame = promise.nextOpportunity;
+	promise.nextOpportunity += promise.self.recharge;
+	promise.scheduler->Schedule(handle, promise.wakeFrame);
+}
+
+BehaviorScheduler::~BehaviorScheduler() {
+	for (Behavior::Handle handle : scripts) { handle.destroy(); }
+}
+
+void BehaviorScheduler::Reserve(std::size_t scriptCount) {
+	queue.reserve(scriptCount);
+	scripts.reserve(scriptCount);
+}
+
+void BehaviorScheduler::Spawn(Behavior&& script, int _frame) {
+	Behavior::Handle handle = std::exchange(script.handle, nullptr); // The scheduler owns the script from now on
+	Behavior::promise_type& promise = handle.promise();
+	const int recharge = promise.self.recharge;
+	promise.scheduler = this;
+	promise.order = spawned++;
+	promise.nextOpportunity = ((_frame + recharge - 1) / recharge) * recharge; // Round up to the first frame where self.IsReady() is true
+	promise.wakeFrame = _frame;
+	scripts.push_back(handle);
+	Schedule(handle, _frame);
+}
+
+void BehaviorScheduler::RunFrame(int frame) {
+	while (!queue.empty() && queue.front().frame <= frame) {
+		std::pop_heap(queue.begin(), queue.end(), Later);
+		Behavior::Handle handle = queue.back().handle;
+		queue.pop_back();
+		handle.resume(); // @ If the script co_awaits NextOpportunity again it pushes itself back onto the queue before resume() returns.
+	}
+}
+
+void BehaviorScheduler::Clear() {
+	for (Behavior::Handle handle : scripts) { handle.destroy(); }
+	scripts.clear();
+	queue.clear();
+	spawned = 0;
+}
+
+void BehaviorScheduler::Schedule(Behavior::Handle handle, int frame) {
+	queue.push_back({ frame, handle.promise().order, handle });
+	std::push_heap(queue.begin(), queue.end(), Later);
+}
+
+#pragma endregion
+
+#pragma region Scripts
+
+// Every animatronic's script: sleep until its recharge timer fires, then take its opprotunity.
+// @ What an opprotunity does is written once, in hwlib (Rules.h). `step` is the character's step out of the night's HwRules,
+// @ looked up once at spawn, so every opprotunity after that goes straight into the ruleset's compiled code.
+Behavior OpportunityBehavior(Night& night, Animatronic& /* self */, HwStep step) {
+	for (;;) {
+		const int frame = co_await NextOpportunity();
+		step(&night, frame);
+		if (night.b_jumpscared) co_return; // Nobody moves after a jumpscare, so there's no reason to keep waking up
+	}
+}
+
+#pragma endregion
+
+void SpawnNight(BehaviorScheduler& scheduler, Night& night, int frame) {
+	// @ Spawn order is the order the animatronics get to act in when several of them are ready on the same frame. It's the same order as hw::Tick.
+	const HwRules& rules = *night.rules;
+	scheduler.Spawn(OpportunityBehavior(night, night.freddy, rules.freddy), frame);
+	scheduler.Spawn(OpportunityBehavior(night, night.foxyyy, rules.foxyyy), frame);
+	scheduler.Spawn(OpportunityBehavior(night, night.bonnie, rules.bonnie), frame);
+	scheduler.Spawn(OpportunityBehavior(night, night.chicaa, rules.chicaa), frame);
+}
+
+int RunBehaviorCheck() {
+	const int nightCount = 512;
+	const int nightLength = 32100; // About 9 minutes at 60 fps, the length of a real night
+	int mismatches = 0;
+	for (int ruleset = 0; ruleset < HW_RULESET_COUNT; ++ruleset) {
+		for (int level = 0; level <= 20; level += 5) {
+			std::vector<Night> scripted;
+			scripted.reserve(nightCount); // @ The scripts hold references to their night, so the vector can't move once they're spawned.
+			std::vector<HwNight> engine(nightCount);
+			BehaviorScheduler scheduler;
+			for (int i = 0; i < nightCount; ++i) {
+				Night& night = scripted.emplace_back(1 + i, (HwRuleset)ruleset);
+				night.freddy.level = night.foxyyy.level = night.bonnie.level = night.chicaa.level = level;
+				night.b_inCams = !(i % 3); // Some nights with the player sat in the cameras, so Freddy's storing & Foxy's waiting get played too
+				HwNight& twin = engine[i] = night; // Same seed, same setup
+				HwRunNight(&twin, 0, nightLength);
+				SpawnNight(scheduler, night);
+			}
+			while (!scheduler.Idle() && scheduler.NextWake() < nightLength) {
+				scheduler.RunFrame(scheduler.NextWake());
+			}
+
+			for (int i = 0; i < nightCount; ++i) {
+				const HwNight& a = scripted[i];
+				const HwNight& b = engine[i];
+				if (a.freddy.position != b.freddy.position || a.foxyyy.position != b.foxyyy.position || a.bonnie.position != b.bonnie.position
+					|| a.chicaa.position != b.chicaa.position || a.freddysStoredCrits != b.freddysStoredCrits || a.b_jumpscared != b.b_jumpscared
+					|| a.attacker != b.attacker || a.jumpscareFrame != b.jumpscareFrame || a.rng != b.rng) {
+					++mismatches;
+				}
+			}
+		}
+	}
+	printf("%d nights didn't match HwRunNight\n", mismatches);
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "hwlib.h"
+
+/*************************************************************************
+*
+*	Behavior scripts
+*
+*	Each animatronic gets a C++20 coroutine that decides when it acts, instead of an `if` block in main():
+*
+*	` for (;;) {
+*	`	const int frame = co_await NextOpportunity();	// Sleep until the animatronic's recharge timer fires
+*	`	step(&night, frame);							// Take the opprotunity
+*	` }
+*
+*	What an opprotunity does is not written here. `step` is the animatronic's compiled step from the night's HwRules (hwlib.h),
+*	the same code hwlib's Tick runs for CSource.c, so the rules only exist once, in Rules.h.
+*
+*	Scripts are resumed by a BehaviorScheduler, which only wakes the scripts that are due on a frame instead of
+*	checking every animatronic every frame. Script frames come out of a BehaviorFramePool, so after a script is
+*	spawned, resuming it never touches the heap.
+*
+*	NOTE: A scheduler, its scripts, and the nights they play on all belong to the thread that spawned them.
+*	To run lots of nights in parallel, give each thread its own scheduler and spawn as many nights onto it as you like.
+*
+**************************************************************************/
+
+// Differenciates characters for use in the Jumpscare function
+// @ The values match HwCharacter so the engine's HwNight::attacker can be cast straight to a Character.
+enum class Character {
+	FREDDY = HW_FREDDY, // Pull animation from Freddy's pool
+	FOXYYY = HW_FOXYYY, // Pull animation from Foxy's pool
+	BONNIE = HW_BONNIE, // Pull animation from Bonnie's pool
+	CHICAA = HW_CHICAA, // Pull animation from Chica's pool
+};
+
+// Type for storing information about an animatronic (position, recharge & AI level). Defined by hwlib.
+using Animatronic = HwAnimatronic;
+
+// Everything the behavior scripts are allowed to read or change about a single night. The fields are all in HwNight (hwlib.h).
+struct Night : HwNight {
+	// Start a fresh night. Every night gets its own RNG so nights running side by side don't fight over rand().
+	Night(unsigned int _seed, HwRuleset _ruleset = HW_RULES_CLASSIC) : HwNight() {
+		HwInitNight(this, _ruleset, _seed);
+	};
+};
+
+// Fixed-size block allocator for behavior script frames
+// @ Every script frame is about the same size, so a free list of equal blocks is all we need. Blocks are handed out from big chunks and
+// @ go back on the free list when the script is destroyed; chunks are only returned to the OS when the thread exits.
+class BehaviorFramePool {
+public:
+	static constexpr std::size_t blockSize = 256; // Frames bigger than this fall back to the regular heap
+	static constexpr std::size_t blocksPerChunk = 1024; // How many blocks get allocated at once when the pool runs dry
+
+	static void* Allocate(std::size_t size);
+	static void Free(void* frame, std::size_t size);
+};
+
+// co_await NextOpportunity() sleeps until the script's animatronic gets its next movement opprotunity, then returns that frame number.
+struct NextOpportunity {};
+
+class BehaviorScheduler;
+
+// A running behavior script. Hand it to BehaviorScheduler::Spawn to start it.
+// The first two parameters of every script must be `Night&` and `Animatronic&` (the night and the animatronic it controls).
+class Behavior {
+public:
+	struct promise_type {
+		template<typename... Extra> // @ Coroutine promises are constructed from the script's own parameters; anything past the first two is ignored here.
+		promise_type(Night& _night, Animatronic& _self, Extra&&...) :
+			night(_night), self(_self), scheduler(nullptr), nextOpportunity(0), wakeFrame(0), order(0) {};
+
+		static void* operator new(std::size_t size) { return BehaviorFramePool::Allocate(size); }
+		static void operator delete(void* frame, std::size_t size) { BehaviorFramePool::Free(frame, size); }
+
+		Behavior get_return_object() { return Behavior(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; } // Scripts don't start until they are spawned
+		std::suspend_always final_suspend() noexcept { return {}; } // The scheduler destroys finished scripts, not the scripts themselves
+		void return_void() {}
+		void unhandled_exception();
+
+		struct OpportunityAwaiter {
+			promise_type& promise;
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<promise_type> handle) const;
+			int await_resume() const noexcept { return promise.wakeFrame; }
+		};
+		OpportunityAwaiter await_transform(NextOpportunity) { return { *this }; }
+
+		Night& night; // The night this script is playing on
+		Animatronic& self; // The animatronic this script controls
+		BehaviorScheduler* scheduler; // Who resumes this script (set by Spawn)
+		int nextOpportunity; // The next frame self.IsReady() will be true
+		int wakeFrame; // The frame this script was last woken up on
+		unsigned int order; // Scripts due on the same frame run in the order they were spawned
+	};
+	using Handle = std::coroutine_handle<promise_type>;
+
+	Behavior(Behavior&& _other) noexcept : handle(std::exchange(_other.handle, nullptr)) {};
+	Behavior(const Behavior&) = delete;
+	Behavior& operator=(const Behavior&) = delete;
+	// A script that was never spawned is destroyed along with its Behavior
+	~Behavior() { if (handle) handle.destroy(); }
+
+private:
+	friend class BehaviorScheduler;
+	explicit Behavior(Handle _handle) : handle(_handle) {};
+	Handle handle;
+};
+
+// Resumes behavior scripts on the frames they are due
+class BehaviorScheduler {
+public:
+	BehaviorScheduler() : spawned(0) {};
+	BehaviorScheduler(const BehaviorScheduler&) = delete;
+	BehaviorScheduler& operator=(const BehaviorScheduler&) = delete;
+	// Destroys every script that was spawned on this scheduler, finished or not
+	~BehaviorScheduler();
+
+	// Make room for this many scripts up front so that spawning them doesn't reallocate
+	void Reserve(std::size_t scriptCount);
+	// Take ownership of a script and let it run up to its first co_await on the first frame >= _frame
+	void Spawn(Behavior&& script, int _frame = 0);
+	// Resume every script that is due on or before this frame
+	void RunFrame(int frame);
+	// Destroy every script, finished or not, but keep the memory reserved for them so the scheduler can be reused
+	void Clear();
+
+	// Whether every script has finished
+	bool Idle() const { return queue.empty(); }
+	// The earliest frame any script is waiting for. Only valid when !Idle().
+	// @ Headless runs can jump straight to this frame instead of calling RunFrame for every frame in between.
+	int NextWake() const { return queue.front().frame; }
+
+private:
+	friend struct Behavior::promise_type::OpportunityAwaiter;
+
+	struct Wake {
+		int frame;
+		unsigned int order;
+		Behavior::Handle handle;
+	};
+	// Min-heap ordering for the wake queue (earliest frame first, then spawn order)
+	static bool Later(const Wake& a, const Wake& b) {
+		return (a.frame != b.frame) ? (a.frame > b.frame) : (a.order > b.order);
+	}
+	void Schedule(Behavior::Handle handle, int frame);
+
+	std::vector<Wake> queue; // Heap of sleeping scripts
+	std::vector<Behavior::Handle> scripts; // Every script this scheduler owns
+	unsigned int spawned; // How many scripts have been spawned so far
+};
+
+// Spawn the behavior scripts for all four animatronics of a night
+void SpawnNight(BehaviorScheduler& scheduler, Night& night, int frame = 0);
+
+// Play the same nights through the scripts and through HwRunNight, for every ruleset and a spread of AI levels.
+// Prints how it went and returns 0 if every night came out the same, 1 otherwise. Run it with `FNaf++ --check`.
+// @ The scripts take hwlib's own opprotunity steps, but *when* each animatronic acts is still decided twice (NextOpportunity here,
+// @ the recharge check in hw::Tick). This is what keeps those two from drifting apart.
+int RunBehaviorCheck();
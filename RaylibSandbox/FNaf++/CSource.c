@@ -2,6 +2,7 @@
 #include <stdbool.h>
 #include <raylib.h>
 #include <raymath.h>
+#include "hwlib.h"
 
 typedef enum Cam {
 	Cam_1A,		// Show stage
@@ -40,26 +41,13 @@ void UnloadSprite(Sprite* sprite) {
 	free(sprite->renders);
 }
 
-typedef struct Animatronic {
-	int position;
-	int recharge;
-	int level;
-} Animatronic;
-void InitAnimatronic(Animatronic* animatronic, int recharge) {
-	animatronic->position = 0;
-	animatronic->recharge = recharge;
-	animatronic->level = 0;
-}
-char IsReady(Animatronic* who, int f) {
-	return !(f % who->recharge);
-}
-
 // Differenciates characters for use in the Jumpscare function
+// @ The values match HwCharacter so the engine's HwNight.attacker can be cast straight to a Character.
 typedef enum {
-	FREDDY, // Pull animation from Freddy's pool
-	FOXYYY, // Pull animation from Foxy's pool
-	BONNIE, // Pull animation from Bonnie's pool
-	CHICAA, // Pull animation from Chica's pool
+	FREDDY = HW_FREDDY, // Pull animation from Freddy's pool
+	FOXYYY = HW_FOXYYY, // Pull animation from Foxy's pool
+	BONNIE = HW_BONNIE, // Pull animation from Bonnie's pool
+	CHICAA = HW_CHICAA, // Pull animation from Chica's pool
 } Character;
 
 void Jumpscare(Character animation) {
@@ -187,14 +175,8 @@ int main1() {
 #pragma endregion
 
 	int frame = 0;
-	bool b_inCams = false;
-	bool b_foxyIsStunned = false; 
-	Animatronic freddy; InitAnimatronic(&freddy, 673);
-	Animatronic foxyyy; InitAnimatronic(&foxyyy, 437);
-	Animatronic bonnie; InitAnimatronic(&bonnie, 284);
-	Animatronic chicaa; InitAnimatronic(&chicaa, 390);
+	HwNight night; HwInitNight(&night, HW_RULES_COINFLIP, rand()); // The animatronics & their rules live in hwlib
 
-	int freddysStoredCrits = 0;
 	bool b_doorL = false;
 	bool b_doorR = false;
 
@@ -202,34 +184,12 @@ int main1() {
 #pragma region Update game variables
 
 		if (IsKeyPressed(KEY_SPACE)) {
-			b_inCams = !b_inCams;
-			if (b_inCams) b_foxyIsStunned = true;
-		}
-		int frameRand = rand();
-		if (IsReady(&freddy, frame)) {
-			++freddysStoredCrits;
-			if (!b_inCams) {
-				freddy.position += (freddysStoredCrits - (frameRand++ % freddysStoredCrits));
-				freddysStoredCrits = 0;
-			}
+			night.b_inCams = !night.b_inCams;
+			if (night.b_inCams) night.b_foxyIsStunned = true;
 		}
-		if (IsReady(&foxyyy, frame) && !b_inCams) {
-			if (!b_foxyIsStunned) foxyyy.position += (frameRand++ & 1);
-			else b_foxyIsStunned = false;
-		}
-		if (IsReady(&bonnie, frame)) {
-			bonnie.position += (frameRand++ & 1);
-
-			if (bonnie.position >= 7) {
-				Jumpscare(BONNIE);
-			}
-		}
-		if (IsReady(&chicaa, frame)) {
-			chicaa.position += (frameRand++ & 1);
-
-			if (chicaa.position >= 7) {
-				Jumpscare(CHICAA);
-			}
+		HwTick(&night, frame);
+		if (night.b_jumpscared) {
+			Jumpscare((Character)night.attacker);
 		}
 
 #pragma endregion
@@ -242,22 +202,22 @@ int main1() {
 			ClearBackground(BLACK);
 
 #if _DEBUG
-			DrawText(TextFormat("Freddy:\nFoxy:\nBonnie:\nChica:\n\nCurrent state: %s", (b_inCams ? "Camera" : "Office")), 0, 0, 8, WHITE);
+			DrawText(TextFormat("Freddy:\nFoxy:\nBonnie:\nChica:\n\nCurrent state: %s", (night.b_inCams ? "Camera" : "Office")), 0, 0, 8, WHITE);
 			DrawText(TextFormat("%i\n%i\n%i\n%i",
-								freddy.position,
-								foxyyy.position,
-								bonnie.position,
-								chicaa.position), 48, 0, 8, WHITE);
+								night.freddy.position,
+								night.foxyyy.position,
+								night.bonnie.position,
+								night.chicaa.position), 48, 0, 8, WHITE);
 			DrawText(TextFormat("%i\n%i\n%i\n%i",
-								frame % freddy.recharge,
-								frame % foxyyy.recharge,
-								frame % bonnie.recharge,
-								frame % chicaa.recharge), 69, 0, 8, WHITE);
+								frame % night.freddy.recharge,
+								frame % night.foxyyy.recharge,
+								frame % night.bonnie.recharge,
+								frame % night.chicaa.recharge), 69, 0, 8, WHITE);
 			DrawText(TextFormat(" / %i (opprotunities: %i)  |  stored crits: %i\n / %i (opprotunities: %i)  |  %s\n / %i (opprotunities: %i)\n / %i (opprotunities: %i)",
-								freddy.recharge, frame / freddy.recharge, freddysStoredCrits,
-								foxyyy.recharge, frame / foxyyy.recharge, (b_foxyIsStunned ? "stunned" : ""),
-								bonnie.recharge, frame / bonnie.recharge,
-								chicaa.recharge, frame / chicaa.recharge), 86, 0, 8, WHITE);
+								night.freddy.recharge, frame / night.freddy.recharge, night.freddysStoredCrits,
+								night.foxyyy.recharge, frame / night.foxyyy.recharge, (night.b_foxyIsStunned ? "stunned" : ""),
+								night.bonnie.recharge, frame / night.bonnie.recharge,
+								night.chicaa.recharge, frame / night.chicaa.recharge), 86, 0, 8, WHITE);
 #endif
 			// TODO: render the animatronics
 
@@ -0,0 +1,353 @@
+#include "NightService.h"
+#include "Behavior.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// @ This file is kept away from raylib.h on purpose: windows.h and raylib.h both declare things like Rectangle and CloseWindow.
+#if _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	// How many nights a worker runs side by side on its scheduler. Bigger jobs are split into chunks of this size so every worker gets a share.
+	constexpr std::uint32_t nightsPerChunk = 4096;
+	// How many chunks can be waiting in the queue per worker before `job` blocks
+	constexpr std::size_t queuedChunksPerWorker = 4;
+	// Biggest region `open` will make
+	constexpr std::uint32_t maxSlots = 1u << 20;
+	// Most nights one `job` can ask for
+	// @ Far below 2^32, so counting up to it a chunk at a time can't wrap around.
+	constexpr std::uint32_t maxNightsPerJob = 1u << 28;
+	// Longest night a `job` can ask for (a bit over 200 days at 60 fps)
+	// @ Scripts schedule themselves up to one recharge past the end of the night, so this leaves plenty of room below INT_MAX.
+	constexpr int maxFrames = 1 << 30;
+
+	// Seed for night `index` of a job
+	// @ The nights' RNG is a plain multiply-and-modulo, so seeding nights with seed, seed + 1, seed + 2, ... would make their rolls move in lockstep.
+	// @ splitmix64 scrambles every bit of (seed, index) into the result, so neighbouring nights get unrelated streams.
+	unsigned int NightSeed(std::uint32_t seed, std::uint32_t index) {
+		std::uint64_t z = ((std::uint64_t)seed << 32 | index) + 0x9E3779B97F4A7C15ull;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return (unsigned int)(z ^ (z >> 31));
+	}
+
+	// Write one of a slot's totals
+	// @ Readers in other processes copy the totals while a job may be writing them, so they're written as relaxed atomics instead of plain stores.
+	// @ The generation counter's release & the reader's acquire fence do all the ordering; the stores only have to not tear.
+	template<typename T>
+	void Store(T& field, T value) {
+		std::atomic_ref<T>(field).store(value, std::memory_order_relaxed);
+	}
+
+	// One chunk of a job
+	struct NightTask {
+		std::uint32_t slot; // Which result the totals go into
+		std::uint32_t firstNight; // Index of the first night of the job this chunk covers
+		std::uint32_t nightCount; // How many nights this chunk covers
+		std::uint32_t seed;
+		int frames; // How long a night lasts
+		int levels[4]; // AI levels, indexed by Character
+		HwRuleset ruleset;
+	};
+
+	// Same as NightResult, minus the generation, so workers can add up a chunk before touching shared memory
+	struct NightTotals {
+		std::uint32_t nights = 0;
+		std::uint32_t survived = 0;
+		std::uint32_t jumpscares[4] = {};
+		std::uint64_t jumpscareFrameSum = 0;
+		std::uint64_t positionSum[4] = {};
+	};
+
+	// Fixed-size queue of chunks. Push blocks while the queue is full, which is what pushes back on the caller.
+	// @ The ring buffer is allocated once up front so queueing a chunk never allocates.
+	class TaskQueue {
+	public:
+		TaskQueue(std::size_t _capacity) : tasks(_capacity), head(0), count(0), b_closed(false) {};
+
+		void Push(const NightTask& task) {
+			std::unique_lock<std::mutex> lock(mutex);
+			notFull.wait(lock, [&] { return count < tasks.size(); });
+			tasks[(head + count) % tasks.size()] = task;
+			++count;
+			notEmpty.notify_one();
+		}
+		// Returns false once the queue has been closed and everything in it has been handed out
+		bool Pop(NightTask& task) {
+			std::unique_lock<std::mutex> lock(mutex);
+			notEmpty.wait(lock, [&] { return count || b_closed; });
+			if (!count) return false;
+			task = tasks[head];
+			head = (head + 1) % tasks.size();
+			--count;
+			notFull.notify_one();
+			return true;
+		}
+		void Close() {
+			std::lock_guard<std::mutex> lock(mutex);
+			b_closed = true;
+			notEmpty.notify_all();
+		}
+
+	private:
+		std::mutex mutex;
+		std::condition_variable notFull, notEmpty;
+		std::vector<NightTask> tasks;
+		std::size_t head, count;
+		bool b_closed;
+	};
+
+	// A named block of memory other processes can map
+	class SharedRegion {
+	public:
+		SharedRegion() : data(nullptr), size(0) {};
+		SharedRegion(const SharedRegion&) = delete;
+		SharedRegion& operator=(const SharedRegion&) = delete;
+		~SharedRegion() { Close(); }
+
+		// Create or re-open the region and zero it. Returns false if the OS said no.
+		bool Open(const std::string& _name, std::size_t _size) {
+			Close();
+#if _WIN32
+			mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((std::uint64_t)_size >> 32), (DWORD)_size, _name.c_str());
+			if (!mapping) return false;
+			data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, _size);
+			if (!data) { CloseHandle(mapping); return false; }
+#else
+			const std::string path = (_name[0] == '/') ? _name : ("/" + _name); // @ POSIX wants the name to start with a slash; Windows doesn't care.
+			const int fd = shm_open(path.c_str(), O_CREAT | O_RDWR, 0600);
+			if (fd < 0) return false;
+			if (ftruncate(fd, (off_t)_size) != 0) { close(fd); return false; }
+			void* view = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			close(fd); // The mapping keeps the memory alive on its own
+			if (view == MAP_FAILED) return false;
+			data = view;
+			name = path;
+#endif
+			size = _size;
+			std::memset(data, 0, size);
+			return true;
+		}
+		void Close() {
+			if (!data) return;
+#if _WIN32
+			UnmapViewOfFile(data);
+			CloseHandle(mapping);
+#else
+			munmap(data, size);
+			shm_unlink(name.c_str()); // @ Only removes the name; callers that already mapped the region can keep reading it.
+#endif
+			data = nullptr;
+			size = 0;
+		}
+
+		bool IsOpen() const { return data != nullptr; }
+		std::size_t Size() const { return size; }
+		NightResultHeader* Header() { return (NightResultHeader*)data; }
+		NightResult* Slots() { return (NightResult*)(Header() + 1); }
+
+	private:
+		void* data;
+		std::size_t size;
+#if _WIN32
+		HANDLE mapping;
+#else
+		std::string name;
+#endif
+	};
+
+	class NightService {
+	public:
+		NightService(unsigned int workerCount) : queue(workerCount * queuedChunksPerWorker), outstandingChunks(0), jobsFinished(0) {
+			for (unsigned int i = 0; i < workerCount; ++i) { workers.emplace_back(&NightService::Work, this); }
+		}
+		~NightService() {
+			queue.Close();
+			for (std::thread& worker : workers) { worker.join(); }
+		}
+
+		// Read commands until quit or end of input
+		int Run(std::istream& in, std::ostream& out) {
+			std::string line, command;
+			while (std::getline(in, line)) {
+				std::istringstream args(line);
+				if (!(args >> command)) continue; // Blank line
+
+				if (command == "open") Open(args, out);
+				else if (command == "job") Job(args, out);
+				else if (command == "wait") out << "done " << Wait() << std::endl;
+				else if (command == "quit") break;
+				else out << "error unknown command '" << command << "'" << std::endl;
+			}
+			Wait();
+			return 0;
+		}
+
+	private:
+		void Open(std::istringstream& args, std::ostream& out) {
+			std::string name;
+			std::uint32_t slots = 0;
+			if (!(args >> name >> slots) || !slots || slots > maxSlots) { out << "error usage: open <name> <slots>" << std::endl; return; }
+
+			Wait(); // Don't pull the region out from under a running job
+			std::lock_guard<std::mutex> lock(resultsMutex);
+			const std::size_t size = sizeof(NightResultHeader) + sizeof(NightResult) * slots;
+			if (!region.Open(name, size)) { out << "error could not open shared memory '" << name << "'" << std::endl; return; }
+
+			NightResultHeader* header = region.Header();
+			header->magic = NightResultHeader::MAGIC;
+			header->version = NightResultHeader::VERSION;
+			header->slotCount = slots;
+			header->slotSize = sizeof(NightResult);
+			chunksLeft.assign(slots, 0);
+			jobsFinished = 0;
+			out << "ok " << size << std::endl;
+		}
+
+		void Job(std::istringstream& args, std::ostream& out) {
+			NightTask task = {};
+			std::uint32_t nights = 0;
+			if (!(args >> task.slot >> nights >> task.seed >> task.frames >> task.levels[0] >> task.levels[1] >> task.levels[2] >> task.levels[3]) || !nights || task.frames <= 0) {
+				out << "error usage: job <slot> <nights> <seed> <frames> <freddy> <foxy> <bonnie> <chica> [classic|coinflip]" << std::endl;
+				return;
+			}
+			if (nights > maxNightsPerJob) { out << "error at most " << maxNightsPerJob << " nights per job" << std::endl; return; }
+			if (task.frames > maxFrames) { out << "error at most " << maxFrames << " frames per night" << std::endl; return; }
+			std::string ruleset = "classic";
+			args >> ruleset; // @ Optional; if it isn't there, ruleset keeps its default.
+			if (ruleset == "classic") task.ruleset = HW_RULES_CLASSIC;
+			else if (ruleset == "coinflip") task.ruleset = HW_RULES_COINFLIP;
+			else { out << "error unknown ruleset '" << ruleset << "'" << std::endl; return; }
+
+			std::uint32_t chunks;
+
+			{
+				std::lock_guard<std::mutex> lock(resultsMutex);
+				if (!region.IsOpen()) { out << "error no shared memory; send open first" << std::endl; return; }
+				if (task.slot >= chunksLeft.size()) { out << "error slot " << task.slot << " is out of range" << std::endl; return; }
+				if (chunksLeft[task.slot]) { out << "error slot " << task.slot << " is still running" << std::endl; return; }
+
+				NightResult& result = region.Slots()[task.slot];
+				result.generation.fetch_add(1, std::memory_order_relaxed); // Odd: a job is running. @ It's always even here, since a slot with a running job was turned away above.
+				std::atomic_thread_fence(std::memory_order_release); // @ Keeps the zeroing below from showing up in shared memory before the odd generation does.
+				Store(result.nights, 0u);
+				Store(result.survived, 0u);
+				for (int i = 0; i < 4; ++i) {
+					Store(result.jumpscares[i], 0u);
+					Store(result.positionSum[i], (std::uint64_t)0);
+				}
+				Store(result.jumpscareFrameSum, (std::uint64_t)0);
+
+				chunks = (nights + nightsPerChunk - 1) / nightsPerChunk;
+				chunksLeft[task.slot] = chunks;
+				outstandingChunks += chunks;
+			}
+
+			// @ Pushing happens outside the lock; if the queue is full this is where the caller gets made to wait.
+			for (task.firstNight = 0; task.firstNight < nights; task.firstNight += nightsPerChunk) {
+				task.nightCount = std::min(nightsPerChunk, nights - task.firstNight);
+				queue.Push(task);
+			}
+			out << "queued " << task.slot << " " << chunks << std::endl;
+		}
+
+		// Block until every queued chunk has been finished. Returns how many jobs have been finished since open.
+		unsigned int Wait() {
+			std::unique_lock<std::mutex> lock(resultsMutex);
+			allDone.wait(lock, [&] { return !outstandingChunks; });
+			return jobsFinished;
+		}
+
+		// What each worker thread does until the queue closes
+		void Work() {
+			// @ Everything a worker needs is set up once here and reused for every chunk, so running a chunk doesn't allocate.
+			std::vector<Night> nights;
+			nights.reserve(nightsPerChunk);
+			BehaviorScheduler scheduler; // @ Declared after nights so it (and the scripts referencing the nights) goes away first.
+			scheduler.Reserve(nightsPerChunk * 4);
+
+			NightTask task;
+			while (queue.Pop(task)) {
+				scheduler.Clear();
+				nights.clear();
+				for (std::uint32_t i = 0; i < task.nightCount; ++i) {
+					Night& night = nights.emplace_back(NightSeed(task.seed, task.firstNight + i), task.ruleset);
+					night.freddy.level = task.levels[(int)Character::FREDDY];
+					night.foxyyy.level = task.levels[(int)Character::FOXYYY];
+					night.bonnie.level = task.levels[(int)Character::BONNIE];
+					night.chicaa.level = task.levels[(int)Character::CHICAA];
+					SpawnNight(scheduler, night);
+				}
+
+				// Nobody is at the controls, so instead of stepping through every frame, jump straight to the next one somebody is waiting for.
+				while (!scheduler.Idle() && scheduler.NextWake() < task.frames) {
+					scheduler.RunFrame(scheduler.NextWake());
+				}
+
+				NightTotals totals;
+				for (const Night& night : nights) {
+					totals.nights++;
+					if (night.b_jumpscared) {
+						totals.jumpscares[(int)night.attacker]++;
+						totals.jumpscareFrameSum += night.jumpscareFrame;
+					}
+					else totals.survived++;
+					totals.positionSum[(int)Character::FREDDY] += night.freddy.position;
+					totals.positionSum[(int)Character::FOXYYY] += night.foxyyy.position;
+					totals.positionSum[(int)Character::BONNIE] += night.bonnie.position;
+					totals.positionSum[(int)Character::CHICAA] += night.chicaa.position;
+				}
+				Finish(task, totals);
+			}
+		}
+
+		// Add a finished chunk into its slot, and mark the slot done if it was the last chunk
+		void Finish(const NightTask& task, const NightTotals& totals) {
+			std::lock_guard<std::mutex> lock(resultsMutex);
+			NightResult& result = region.Slots()[task.slot];
+			// @ Only workers holding resultsMutex write the totals, so reading them back plainly here can't race with another write.
+			Store(result.nights, result.nights + totals.nights);
+			Store(result.survived, result.survived + totals.survived);
+			for (int i = 0; i < 4; ++i) {
+				Store(result.jumpscares[i], result.jumpscares[i] + totals.jumpscares[i]);
+				Store(result.positionSum[i], result.positionSum[i] + totals.positionSum[i]);
+			}
+			Store(result.jumpscareFrameSum, result.jumpscareFrameSum + totals.jumpscareFrameSum);
+
+			if (!--chunksLeft[task.slot]) {
+				result.generation.fetch_add(1, std::memory_order_release); // Even: done. @ Release, so a reader that sees the even generation also sees everything written above.
+				jobsFinished++;
+			}
+			if (!--outstandingChunks) allDone.notify_all();
+		}
+
+		TaskQueue queue;
+		SharedRegion region;
+		std::mutex resultsMutex; // Guards the region, chunksLeft, outstandingChunks & jobsFinished
+		std::condition_variable allDone;
+		std::vector<std::uint32_t> chunksLeft; // How many chunks of each slot's job are still running
+		unsigned int outstandingChunks; // How many chunks are queued or running across all slots
+		unsigned int jobsFinished;
+		std::vector<std::thread> workers; // @ Declared last so the threads start after everything they use has been constructed.
+	};
+}
+
+int RunNightService() {
+	NightService service(std::max(1u, std::thread::hardware_concurrency()));
+	return service.Run(std::cin, std::cout);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/*************************************************************************
+*
+*	Night simulation service
+*
+*	Running `FNaf++ --service` skips the window and turns the game into a long-running process that simulates
+*	whole nights without drawing anything. Balancing scripts feed it jobs over stdin and read the results
+*	straight out of a shared-memory region, so the process (and its worker threads) only has to start once.
+*
+*	Commands are one per line. Replies are one line each on stdout.
+*
+*		open <name> <slots>
+*			Create (or re-open) the shared-memory region <name> with room for <slots> results.
+*			Replies `ok <size in bytes>`.
+*
+*		job <slot> <nights> <seed> <frames> <freddy> <foxy> <bonnie> <chica> [classic|coinflip]
+*			Simulate <nights> nights of <frames> frames each with the given AI levels and write the totals into <slot>.
+*			The last word picks the ruleset (see HwRuleset in hwlib.h); it defaults to classic.
+*			<nights> can be at most 2^28 and <frames> at most 2^30.
+*			Night i is seeded with the low 32 bits of splitmix64((<seed> << 32) | i), so the same job always gives the same result
+*			but neighbouring nights don't get related dice rolls.
+*			Replies `queued <slot> <chunks>` once every chunk of the job is in the queue (the job runs in chunks of up to 4096 nights).
+*			Until then this blocks whenever the job queue is full, which is what keeps a fast caller from running the service out of memory.
+*
+*		wait
+*			Block until every job sent so far has finished. Replies `done <jobs finished since open>`.
+*
+*		quit
+*			Finish outstanding jobs and exit. Closing stdin does the same thing.
+*
+*	Anything that goes wrong is reported as `error <message>` in place of the command's usual reply, and the service keeps going.
+*	So every command except quit gets exactly one reply line, in the order the commands were sent.
+*
+*	The region is a NightResultHeader followed by <slots> NightResults. Each slot has a `generation` counter:
+*	it's 0 until the slot's first job, odd while a job is running, and even once that job is finished.
+*	A new job bumps it to odd (and fences) before it clears the totals, and the last chunk bumps it to even with release ordering
+*	after every total has been written. The totals themselves are only ever written with relaxed atomic stores.
+*	To read a slot without any locking:
+*
+*		1. Load `generation` (acquire). If it's 0 or odd, the slot isn't ready.
+*		2. Copy the fields you want.
+*		3. Issue an acquire fence (std::atomic_thread_fence(std::memory_order_acquire)), so the copy can't be reordered past step 4.
+*		4. Load `generation` again (relaxed is fine after the fence). If it's the same number as in step 1, the copy is good;
+*		   otherwise a job ran on the slot while you were reading, so throw the copy away.
+*
+*	Because every job moves the counter on by two, step 4 also catches a whole job starting and finishing between steps 1 and 4.
+*
+**************************************************************************/
+
+// Start of the shared-memory region
+struct NightResultHeader {
+	static constexpr std::uint32_t MAGIC = 0x464E6166; // "FNaf"
+	static constexpr std::uint32_t VERSION = 2; // 2: `state` became `generation`
+
+	std::uint32_t magic;
+	std::uint32_t version;
+	std::uint32_t slotCount; // How many NightResults follow the header
+	std::uint32_t slotSize; // sizeof(NightResult), so readers can check they agree on the layout
+};
+
+// Totals for one job
+struct NightResult {
+	std::atomic<std::uint32_t> generation; // 0 before the first job, odd while a job runs, even once it's done (see the read steps above)
+	std::uint32_t nights; // How many nights were simulated
+	std::uint32_t survived; // How many of them nobody got into the office
+	std::uint32_t jumpscares[4]; // How many nights each character got in, indexed by Character
+	std::uint32_t reserved;
+	std::uint64_t jumpscareFrameSum; // Sum of the frames the jumpscares happened on (divide by nights - survived for the average)
+	std::uint64_t positionSum[4]; // Sum of where each character ended the night, indexed by Character
+};
+static_assert(sizeof(NightResultHeader) == 16, "NightResultHeader is read by other programs; don't change its layout");
+static_assert(sizeof(NightResult) == 72, "NightResult is read by other programs; don't change its layout");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "NightResult::generation has to be lock-free to work across processes");
+static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free, "NightResult's totals are written atomically and have to be lock-free to work across processes");
+
+// Run the service until quit or end of input. Returns the process exit code.
+int RunNightService();
@@ -1,7 +1,10 @@
 #include <raylib.h>
 #include <raymath.h>
+#include <cstring>
 #include <random>
 #include <vector>
+#include "Behavior.h"
+#include "NightService.h"
 /*************************************************************************
 * 
 *	This project uses Raylib (https://www.raylib.com/)
@@ -111,35 +114,6 @@ struct Sprite {
 	Texture2D* renders; // Pointer to array of renders
 };
 
-// Type for storing information about an animatronic
-struct Animatronic {
-	// Construct the animatronic with its base charge time
-	// There is no default constructor. Animatronic recharge is required as a non-default due to it being a const.
-	Animatronic(int _recharge) : position(0), recharge(_recharge), level(0) {};
-	// Where the animatronic is in the building
-	// refers to the index in the animatronic's Renders array
-	int position;
-	// How many frames between movement opprotunities
-	// Do not increment/decrement this, it should stay the same at all times once initialized.
-	const int recharge;
-	// The AI level of the animatronic
-	// Movement oppronity RNG will be compared against this number to determine success of the "dice roll" (expected 0..20)
-	int level;
-
-	// Whether the animatronic has the opprotunity to move this frame. They will still need to succeed the RNG to actually move.
-	bool IsReady(int f) {
-		return !(f % recharge); // If the frame evenly modulos by the recharge time, the animatronic has the opprotunity to move.
-	}
-};
-
-// Differenciates characters for use in the Jumpscare function
-enum class Character {
-	FREDDY, // Pull animation from Freddy's pool
-	FOXYYY, // Pull animation from Foxy's pool
-	BONNIE, // Pull animation from Bonnie's pool
-	CHICAA, // Pull animation from Chica's pool
-};
-
 void Jumpscare(Character animation) {
 	switch (animation) {
 	case Character::FREDDY:
@@ -160,7 +134,14 @@ void Jumpscare(Character animation) {
 	}
 }
 
-int main() {
+int main(int argc, char** argv) {
+	if (argc > 1 && !strcmp(argv[1], "--service")) { // Headless: no window, no textures. See NightService.h for how to talk to it.
+		return RunNightService();
+	}
+	if (argc > 1 && !strcmp(argv[1], "--check")) { // Headless: check the behavior scripts still play the same nights as hwlib. See RunBehaviorCheck.
+		return RunBehaviorCheck();
+	}
+
 	const int windowWidth = 1920; // FHD screen resolution for width
 	const int windowHeight = 1080; // FHD screen resolution for height
 	InitWindow(windowWidth, windowHeight, "FNaF++"); // Create the window the game will run in
@@ -272,14 +253,9 @@ int main() {
 #pragma endregion
 
 	int frame = 0; // What frame we are on @ The frame number can be a clean integer, time would be a float and may not line up with the times we are performing calculations.
-	bool b_inCams = false; // Whether the player is looking at the cameras
-	bool b_foxyIsStunned = false; // Foxy must wait for both b_inCams & b_foxyIsStunned to both be false before he can move.
-	Animatronic // @ The following comma-separated identifiers (variable names) will all be of the type Animatronic until a semicolon is reached.
-		freddy(673), // Freddy @ Following the variable name with parenthesis containing parameters that are valid with a constructor for the type calls the constructor on the variable in the same line it is declared.
-		foxyyy(437), // Foxy   @ Note that Animatronic does not have a default constructor. If we declared these variables without calling the specialized constructor, it would give an error. This is on purpose.
-		bonnie(284), // Bonnie
-		chicaa(390); // Chica
-	int freddysStoredCrits = 0; // Freddy stores movement opprotunities for later use
+	Night night(std::random_device{}()); // Positions, AI levels & RNG of the animatronics. Their rules live in hwlib.
+	BehaviorScheduler scheduler; // Wakes up the animatronics' behavior scripts on the frames they get an opprotunity to move
+	SpawnNight(scheduler, night);
 	bool b_doorL = false; bool b_doorR = false;
 	bool b_lampL = false; bool b_lampR = false;
 	float battery = 100.0f; // How much power is remaining
@@ -306,35 +282,14 @@ int main() {
 		if (b_lampR) battery -= 0.01f;
 
 		if (IsKeyPressed(KEY_SPACE)) { // If the space key was pressed this frame,
-			b_inCams = !b_inCams; // Toggle the "are we watching the cameras" bool
-			if (b_inCams) b_foxyIsStunned = true; // Then, if we are *now* in the cameras (meaning we've entered the cam this frame), stun Foxy.
+			night.b_inCams = !night.b_inCams; // Toggle the "are we watching the cameras" bool
+			if (night.b_inCams) night.b_foxyIsStunned = true; // Then, if we are *now* in the cameras (meaning we've entered the cam this frame), stun Foxy.
 		}
 
-		if (freddy.IsReady(frame)) {
-			freddysStoredCrits++;
-			if (!b_inCams) {
-				while (freddysStoredCrits--) {
-					freddy.position += ((rand() % 20) > freddy.level);
-				}
-			}
-		}
-		if (foxyyy.IsReady(frame) && !b_inCams) {
-			if (!b_foxyIsStunned) foxyyy.position += ((rand() % 20) > foxyyy.level);
-			else b_foxyIsStunned = false;
-		}
-		if (bonnie.IsReady(frame)) {
-			bonnie.position += ((rand() % 20) > bonnie.level);
+		scheduler.RunFrame(frame); // Let every animatronic that has an opprotunity this frame take it
 
-			if (bonnie.position >= 7) { // Invalid index; no render exists for this so we will instead initiate the jumpscare sequence.
-				Jumpscare(Character::BONNIE);
-			}
-		}
-		if (chicaa.IsReady(frame)) {
-			chicaa.position += ((rand() % 20) > chicaa.level);
-
-			if (chicaa.position >= 7) { // Invalid index; no render exists for this so we will instead initiate the jumpscare sequence.
-				Jumpscare(Character::CHICAA);
-			}
+		if (night.b_jumpscared) {
+			Jumpscare((Character)night.attacker);
 		}
 
 		#pragma endregion
@@ -346,7 +301,7 @@ int main() {
 			// Rendering
 			ClearBackground(BLACK); // Clears the frame to be totally black at the start of rendering, giving us a clean slate to work off of.
 
-			if (b_inCams) {
+			if (night.b_inCams) {
 				DrawTexturePro(
 					staticRender,
 					{ windowHalfWidth * (float)(frame % 4 < 2), windowHalfHeight * (float)(frame & 1), windowHalfWidth, windowHalfHeight },
@@ -361,7 +316,7 @@ int main() {
 			// Print the debug data
 			// Split into multiple sections because the default Raylib font isn't monospace
 			DrawText(TextFormat("Freddy:\nFoxy:\nBonnie:\nChica:\n\nLooking at: %s\nBattery: %u\n\nLeft door: %s\nRight door: %s\nLeft light: %s\nRight light: %s",
-								(b_inCams ? "Camera" : "Office"),
+								(night.b_inCams ? "Camera" : "Office"),
 								(unsigned int)(battery),
 								(b_doorL ? "closed" : "open"),
 								(b_doorR ? "closed" : "open"),
@@ -369,22 +324,22 @@ int main() {
 								(b_lampR ? "on" : "off")
 			), 0, 0, 8, WHITE);
 			DrawText(TextFormat("%i\n%i\n%i\n%i",
-								freddy.position,
-								foxyyy.position,
-								bonnie.position,
-								chicaa.position
+								night.freddy.position,
+								night.foxyyy.position,
+								night.bonnie.position,
+								night.chicaa.position
 			), 48, 0, 8, WHITE);
 			DrawText(TextFormat("%i\n%i\n%i\n%i",
-								frame % freddy.recharge,
-								frame % foxyyy.recharge,
-								frame % bonnie.recharge,
-								frame % chicaa.recharge
+								frame % night.freddy.recharge,
+								frame % night.foxyyy.recharge,
+								frame % night.bonnie.recharge,
+								frame % night.chicaa.recharge
 			), 69, 0, 8, WHITE);
 			DrawText(TextFormat(" / %i (opprotunities: %i)  |  stored crits: %i\n / %i (opprotunities: %i)  |  %s\n / %i (opprotunities: %i)\n / %i (opprotunities: %i)",
-								freddy.recharge, frame / freddy.recharge, freddysStoredCrits,
-								foxyyy.recharge, frame / foxyyy.recharge, (b_foxyIsStunned ? "stunned" : ""),
-								bonnie.recharge, frame / bonnie.recharge,
-								chicaa.recharge, frame / chicaa.recharge
+								night.freddy.recharge, frame / night.freddy.recharge, night.freddysStoredCrits,
+								night.foxyyy.recharge, frame / night.foxyyy.recharge, (night.b_foxyIsStunned ? "stunned" : ""),
+								night.bonnie.recharge, frame / night.bonnie.recharge,
+								night.chicaa.recharge, frame / night.chicaa.recharge
 			), 86, 0, 8, WHITE);
 		#endif
 			// TODO: render the animatronics
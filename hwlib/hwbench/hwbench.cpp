@@ -0,0 +1,110 @@
+// hwbench.cpp : Times both rulesets through every way of calling into hwlib, against a copy of the game that isn't specialized.
+//
+// "runtime"    is the baseline: hw::Run with a ruleset that checks which ruleset the night uses every time it rolls or spends Freddy's crits.
+//              That's one copy of the game for every ruleset, which is what hwlib would be without the templates.
+// "template"   calls hw::Run<Rules> directly, so the whole night is inlined into this file. This is as fast as the engine can go.
+// "HwRunNight" goes through the C API once per night, the way a batch simulation would.
+// "HwTick"     goes through the C API once per frame, the way CSource.c does.
+//
+// What specializing buys is "runtime" vs "template" (the last column). The three specialized paths all run the same compiled
+// hw::Tick<Rules>, so they only show what calling through the C API costs.
+// Every path has to end up with exactly the same nights (the checksum column). If they don't, the benchmark says so and exits with 1.
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "hwlib.h"
+#include "Rules.h"
+
+namespace {
+	const int nightCount = 2048;
+	const int nightLength = 32100; // About 9 minutes at 60 fps, the length of a real night
+
+	// Fresh nights with every AI level set the same, so both rulesets get the same setup
+	std::vector<HwNight> MakeNights(HwRuleset ruleset) {
+		std::vector<HwNight> nights(nightCount);
+		for (int i = 0; i < nightCount; ++i) {
+			HwInitNight(&nights[i], ruleset, 1 + i);
+			nights[i].freddy.level = nights[i].foxyyy.level = nights[i].bonnie.level = nights[i].chicaa.level = 10;
+		}
+		return nights;
+	}
+
+	// How many frames actually got simulated (nights stop early on a jumpscare), and a fingerprint of where everybody ended up
+	void Tally(const std::vector<HwNight>& nights, long long& frames, unsigned long long& checksum) {
+		frames = 0;
+		checksum = 0;
+		for (const HwNight& night : nights) {
+			frames += night.b_jumpscared ? (night.jumpscareFrame + 1) : nightLength;
+			checksum = checksum * 31 + (unsigned long long)(night.freddy.position + 8 * night.foxyyy.position + 64 * night.bonnie.position + 512 * night.chicaa.position);
+			checksum = checksum * 31 + (unsigned long long)night.jumpscareFrame;
+		}
+	}
+
+	// The unspecialized baseline: picks the ruleset at run time, on every call
+	// @ The ruleset comes from the night itself (its rules pointer), so the compiler can't know it ahead of time and fold the branch away.
+	struct RuntimeRules {
+		static bool IsClassic(const HwNight& night) {
+			static const HwRules* const classic = HwGetRules(HW_RULES_CLASSIC);
+			return night.rules == classic;
+		}
+		static int Roll(HwNight& night, int frame, int level) {
+			if (IsClassic(night)) return hw::ClassicRules::Roll(night, frame, level);
+			return hw::CoinFlipRules::Roll(night, frame, level);
+		}
+		static void SpendFreddysCrits(HwNight& night, int frame) {
+			if (IsClassic(night)) hw::ClassicRules::SpendFreddysCrits(night, frame);
+			else hw::CoinFlipRules::SpendFreddysCrits(night, frame);
+		}
+	};
+
+	struct Timing {
+		unsigned long long checksum; // Fingerprint of the nights that were played
+		double nsPerFrame;
+	};
+
+	template<class Path>
+	Timing Time(const char* rulesetName, HwRuleset ruleset, const char* pathName, Path path) {
+		std::vector<HwNight> nights = MakeNights(ruleset);
+		const auto start = std::chrono::steady_clock::now();
+		for (HwNight& night : nights) { path(night); }
+		const auto end = std::chrono::steady_clock::now();
+
+		long long frames;
+		unsigned long long checksum;
+		Tally(nights, frames, checksum);
+		const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+		printf("%-9s %-11s %10.2f ns/frame %8.1f ms   checksum %016llx", rulesetName, pathName, ns / (double)frames, ns / 1e6, checksum);
+		return { checksum, ns / (double)frames };
+	}
+
+	// Returns whether every path played the exact same nights
+	template<class Rules>
+	bool Bench(const char* rulesetName, HwRuleset ruleset) {
+		const Timing runtime = Time(rulesetName, ruleset, "runtime", [](HwNight& night) { hw::Run<RuntimeRules>(night, 0, nightLength); });
+		printf("   (baseline)\n");
+		// Prints how fast a path was next to the baseline, and returns whether it played the same nights
+		const auto vsRuntime = [&](const Timing& timing) {
+			printf("   %5.2fx as fast as runtime\n", runtime.nsPerFrame / timing.nsPerFrame);
+			return timing.checksum == runtime.checksum;
+		};
+
+		bool b_same = vsRuntime(Time(rulesetName, ruleset, "template", [](HwNight& night) { hw::Run<Rules>(night, 0, nightLength); }));
+		b_same &= vsRuntime(Time(rulesetName, ruleset, "HwRunNight", [](HwNight& night) { HwRunNight(&night, 0, nightLength); }));
+		b_same &= vsRuntime(Time(rulesetName, ruleset, "HwTick", [](HwNight& night) {
+			for (int frame = 0; frame < nightLength && !night.b_jumpscared; ++frame) { HwTick(&night, frame); }
+		}));
+		if (b_same) return true;
+		printf("%-9s MISMATCH: the paths didn't all play the same nights\n", rulesetName);
+		return false;
+	}
+}
+
+int main() {
+	printf("%d nights of %d frames per run\n\n", nightCount, nightLength);
+	bool b_same = true;
+	b_same &= Bench<hw::ClassicRules>("classic", HW_RULES_CLASSIC);
+	printf("\n");
+	b_same &= Bench<hw::CoinFlipRules>("coinflip", HW_RULES_COINFLIP);
+	return b_same ? 0 : 1;
+}
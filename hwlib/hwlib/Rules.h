@@ -0,0 +1,106 @@
+// Rules.h : The game logic, written once and compiled once per ruleset.
+//
+// A ruleset is a struct of static functions (a "policy") that gets passed to the templates below as a template parameter.
+// The compiler makes a separate copy of Tick/Run/the opprotunities for every ruleset and inlines the ruleset's functions
+// into it, so the finished code never has to check which ruleset it's playing by.
+//
+// To add a ruleset: write a struct with the same two functions as ClassicRules (Roll & SpendFreddysCrits), add a value to HwRuleset in hwlib.h,
+// and add its table to HwGetRules in hwlib.cpp.
+
+#pragma once
+#include "hwlib.h"
+
+namespace hw {
+	// Advance a night's RNG and return the new value (1..2147483646)
+	// @ This is the "minimal standard" generator, the same one as std::minstd_rand. It's one multiply and one modulo, and the whole state fits in an int.
+	inline unsigned int NextRandom(HwNight& night) {
+		night.rng = (unsigned int)(((unsigned long long)night.rng * 48271u) % 2147483647u);
+		return night.rng;
+	}
+
+	// Source.cpp's rules
+	struct ClassicRules {
+		// Roll a d20; the animatronic moves if it comes up higher than its AI level
+		static int Roll(HwNight& night, int, int level) {
+			return (int)(NextRandom(night) % 20) > level;
+		}
+		// Freddy rolls once for every opprotunity he saved up
+		static void SpendFreddysCrits(HwNight& night, int frame) {
+			while (night.freddysStoredCrits > 0) {
+				night.freddysStoredCrits--;
+				night.freddy.position += Roll(night, frame, night.freddy.level);
+			}
+		}
+	};
+
+	// CSource.c's rules
+	struct CoinFlipRules {
+		// Every coin flip on a frame comes from one random number: each flip takes its low bit, then adds one to it.
+		// So flips on the same frame alternate (if Bonnie and Chica both flip on a frame, exactly one of them moves).
+		// @ That's how CSource.c did it (`frameRand++ & 1`), and it's kept on purpose so the ruleset plays the same.
+		// @ The random number is only drawn the first time somebody flips on a frame, so frames where nobody moves don't cost an RNG step.
+		static unsigned int& FrameRand(HwNight& night, int frame) {
+			if (night.randFrame != frame) {
+				night.frameRand = NextRandom(night);
+				night.randFrame = frame;
+			}
+			return night.frameRand;
+		}
+		// Flip a coin; the AI level doesn't matter
+		static int Roll(HwNight& night, int frame, int) {
+			return (int)(FrameRand(night, frame)++ & 1);
+		}
+		// Freddy cashes in all of his saved opprotunities with one roll, moving at least one space
+		static void SpendFreddysCrits(HwNight& night, int frame) {
+			night.freddy.position += night.freddysStoredCrits - (int)(FrameRand(night, frame)++ % (unsigned int)night.freddysStoredCrits);
+			night.freddysStoredCrits = 0;
+		}
+	};
+
+	// Freddy stores every opprotunity he gets while he's being watched, then spends them all at once when the player looks away.
+	template<class Rules>
+	void FreddyOpportunity(HwNight& night, int frame) {
+		if (night.b_jumpscared) return;
+		night.freddysStoredCrits++;
+		if (!night.b_inCams) Rules::SpendFreddysCrits(night, frame);
+	}
+
+	// Foxy only moves while the player isn't watching, and looking at the cameras stuns him until he wastes one opprotunity.
+	template<class Rules>
+	void FoxyOpportunity(HwNight& night, int frame) {
+		if (night.b_jumpscared || night.b_inCams) return;
+		if (!night.b_foxyIsStunned) night.foxyyy.position += Rules::Roll(night, frame, night.foxyyy.level);
+		else night.b_foxyIsStunned = false;
+	}
+
+	// Bonnie and Chica walk up to their door no matter what the player is doing. Walking past the door means they're in the office.
+	template<class Rules, HwAnimatronic HwNight::* self, HwCharacter who> // @ `self` is a pointer-to-member, so night.*self is night.bonnie or night.chicaa, picked at compile time.
+	void DoorOpportunity(HwNight& night, int frame) {
+		if (night.b_jumpscared) return;
+		HwAnimatronic& animatronic = night.*self;
+		animatronic.position += Rules::Roll(night, frame, animatronic.level);
+		if (animatronic.position >= 7) { // Invalid index; no render exists for this so we will instead initiate the jumpscare sequence.
+			night.b_jumpscared = true;
+			night.attacker = who;
+			night.jumpscareFrame = frame;
+		}
+	}
+
+	// Run one frame: every animatronic whose recharge timer fires this frame takes its opprotunity, in the order Freddy, Foxy, Bonnie, Chica.
+	template<class Rules>
+	void Tick(HwNight& night, int frame) {
+		if (!(frame % night.freddy.recharge)) FreddyOpportunity<Rules>(night, frame);
+		if (!(frame % night.foxyyy.recharge)) FoxyOpportunity<Rules>(night, frame);
+		if (!(frame % night.bonnie.recharge)) DoorOpportunity<Rules, &HwNight::bonnie, HW_BONNIE>(night, frame);
+		if (!(frame % night.chicaa.recharge)) DoorOpportunity<Rules, &HwNight::chicaa, HW_CHICAA>(night, frame);
+	}
+
+	// Run a stretch of frames, stopping early if somebody gets into the office
+	template<class Rules>
+	void Run(HwNight& night, int firstFrame, int frameCount) {
+		const int end = firstFrame + frameCount;
+		for (int frame = firstFrame; frame < end && !night.b_jumpscared; ++frame) {
+			Tick<Rules>(night, frame);
+		}
+	}
+}
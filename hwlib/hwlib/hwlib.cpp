@@ -3,8 +3,61 @@
 
 #include "pch.h"
 #include "framework.h"
+#include "hwlib.h"
+#include "Rules.h"
 
-// TODO: This is an example of a library function
-void fnhwlib()
-{
+namespace {
+	// Wrappers with C signatures around one ruleset's copy of the game, so they can go in an HwRules table
+	template<class Rules>
+	struct Compiled {
+		static void Tick(HwNight* night, int frame) { hw::Tick<Rules>(*night, frame); }
+		static void Run(HwNight* night, int firstFrame, int frameCount) { hw::Run<Rules>(*night, firstFrame, frameCount); }
+		template<void (*step)(HwNight&, int)>
+		static void Opportunity(HwNight* night, int frame) { step(*night, frame); }
+
+		static const HwRules table;
+	};
+	template<class Rules>
+	const HwRules Compiled<Rules>::table = {
+		&Compiled::Tick,
+		&Compiled::Run,
+		&Compiled::template Opportunity<hw::FreddyOpportunity<Rules>>,
+		&Compiled::template Opportunity<hw::FoxyOpportunity<Rules>>,
+		&Compiled::template Opportunity<hw::DoorOpportunity<Rules, &HwNight::bonnie, HW_BONNIE>>,
+		&Compiled::template Opportunity<hw::DoorOpportunity<Rules, &HwNight::chicaa, HW_CHICAA>>,
+	};
+}
+
+const HwRules* HwGetRules(HwRuleset ruleset) {
+	switch (ruleset) {
+	case HW_RULES_CLASSIC:  return &Compiled<hw::ClassicRules>::table;
+	case HW_RULES_COINFLIP: return &Compiled<hw::CoinFlipRules>::table;
+	default:                return nullptr;
+	}
+}
+
+bool HwInitNight(HwNight* night, HwRuleset ruleset, unsigned int seed) {
+	*night = HwNight(); // Zero everything, then fill in what isn't zero
+	night->freddy.recharge = 673;
+	night->foxyyy.recharge = 437;
+	night->bonnie.recharge = 284;
+	night->chicaa.recharge = 390;
+	night->jumpscareFrame = -1;
+	night->rng = seed % 2147483647u;
+	if (!night->rng) night->rng = 1; // @ A state of 0 would get stuck at 0 forever
+	night->randFrame = -1;
+	night->rules = HwGetRules(ruleset);
+	if (!night->rules) { // @ C callers can pass any int here; fall back to a ruleset that exists so HwTick never calls through NULL.
+		night->rules = HwGetRules(HW_RULES_CLASSIC);
+		return false;
+	}
+	return true;
+}
+
+void HwTick(HwNight* night, int frame) {
+	night->rules->tick(night, frame);
+}
+
+void HwRunNight(HwNight* night, int firstFrame, int frameCount) {
+	night->rules->run(night, firstFrame, frameCount);
 }
@@ -0,0 +1,90 @@
+// hwlib.h : The game engine shared by the C and C++ versions of FNaF++.
+//
+// Everything in here is plain C so that CSource.c can use it as-is. The engine itself is written in C++ (see Rules.h);
+// each ruleset gets its own compiled copy of the game logic, and the functions below just hand you the right copy.
+
+#ifndef HWLIB_H
+#define HWLIB_H
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Which version of the rules a night is played with
+typedef enum HwRuleset {
+	HW_RULES_CLASSIC,	// Source.cpp's rules: every move is a d20 roll against the AI level, and Freddy spends his stored crits one roll at a time.
+	HW_RULES_COINFLIP,	// CSource.c's rules: every move is a coin flip, and Freddy cashes in all of his stored crits with a single roll.
+
+	HW_RULESET_COUNT
+} HwRuleset;
+
+// Differenciates characters
+typedef enum HwCharacter {
+	HW_FREDDY,
+	HW_FOXYYY,
+	HW_BONNIE,
+	HW_CHICAA,
+} HwCharacter;
+
+// Type for storing information about an animatronic
+typedef struct HwAnimatronic {
+	int position;	// Where the animatronic is in the building (index into the animatronic's renders)
+	int recharge;	// How many frames between movement opprotunities. Don't change this after HwInitNight.
+	int level;		// The AI level the dice are rolled against (expected 0..20)
+} HwAnimatronic;
+
+// Everything about a single night the engine reads or changes
+typedef struct HwNight {
+	HwAnimatronic freddy, foxyyy, bonnie, chicaa;
+
+	int freddysStoredCrits;	// Freddy stores movement opprotunities for later use
+	bool b_inCams;			// Whether the player is looking at the cameras. Set this from your input code.
+	bool b_foxyIsStunned;	// Set this when the player enters the cameras. Foxy wastes his next opprotunity clearing it.
+
+	bool b_jumpscared;		// Whether somebody got into the office. Nobody moves after this is set.
+	HwCharacter attacker;	// Who got into the office (only meaningful once b_jumpscared is set)
+	int jumpscareFrame;		// What frame they got in on (-1 until then)
+
+	unsigned int rng;		// RNG state. Every night has its own, so nights can run side by side.
+	unsigned int frameRand;	// HW_RULES_COINFLIP: the random number the current frame's coin flips come from
+	int randFrame;			// HW_RULES_COINFLIP: the frame frameRand was drawn for
+
+	const struct HwRules* rules; // The compiled rules for this night's ruleset (set by HwInitNight)
+} HwNight;
+
+typedef void (*HwStep)(HwNight* night, int frame);
+
+// One ruleset's compiled copy of the game. Look it up once, then call straight into it.
+// tick & run play whole frames. The four opprotunity steps are what tick does for each animatronic, for front ends
+// (like the C++ behavior scripts) that decide for themselves who gets an opprotunity when.
+typedef struct HwRules {
+	HwStep tick;											// Run one frame: every animatronic that is ready this frame takes its opprotunity.
+	void (*run)(HwNight* night, int firstFrame, int frameCount);	// Run a whole stretch of frames in one call (stops early on a jumpscare).
+	HwStep freddy;											// Freddy takes an opprotunity (stores it, and spends his crits if the player isn't in the cameras).
+	HwStep foxyyy;											// Foxy takes an opprotunity (only while the player isn't in the cameras).
+	HwStep bonnie;											// Bonnie takes an opprotunity (and jumpscares if she walks past the door).
+	HwStep chicaa;											// Chica takes an opprotunity (and jumpscares if she walks past the door).
+} HwRules;
+
+// Get the compiled rules for a ruleset. Returns NULL if `ruleset` isn't one of the HwRuleset values.
+const HwRules* HwGetRules(HwRuleset ruleset);
+
+// Start a fresh night with the usual recharge times, every AI level at 0, and the RNG seeded with `seed`
+// Returns false if `ruleset` isn't one of the HwRuleset values; the night is still set up, just with HW_RULES_CLASSIC, so it's always safe to tick.
+bool HwInitNight(HwNight* night, HwRuleset ruleset, unsigned int seed);
+
+// Run one frame of the night
+void HwTick(HwNight* night, int frame);
+
+// Run frameCount frames of the night starting at firstFrame
+void HwRunNight(HwNight* night, int firstFrame, int frameCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //HWLIB_H